@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define BITLANG_PRIV
+#include "bitlang.h"
+
+/*
+ * Ahead-of-time driver.
+ *
+ * aot "expr" [w h t] writes a complete C program to stdout,
+ * made of the generated function and a main() that renders
+ * one frame to stdout as a PBM.
+ *
+ * aot -i "expr" [w h t] renders the same frame with the
+ * interpreter, so the two outputs can be compared.
+ */
+
+static void writepbm(FILE *fp, unsigned char *pixels, int w, int h)
+{
+    int x, y;
+
+    fprintf(fp, "P1\n# bitlang test image\n%d %d\n", w, h);
+
+    for (y = 0; y < h; y++) {
+        for (x = 0; x < w; x++) {
+            if (x != 0) {
+                fputc(' ', fp);
+            }
+
+            if (pixels[y*w + x]) fputc('1', fp);
+            else fputc('0', fp);
+        }
+
+        fputc('\n', fp);
+    }
+}
+
+static void writemain(FILE *fp, int w, int h, int t)
+{
+    fprintf(fp, "\n#include <stdio.h>\n\n");
+    fprintf(fp, "static unsigned char pixels[%d][%d];\n\n", h, w);
+    fprintf(fp, "int main(void)\n");
+    fprintf(fp, "{\n");
+    fprintf(fp, "    int x, y;\n");
+    fprintf(fp, "    int err;\n\n");
+    fprintf(fp, "    err = 0;\n\n");
+    fprintf(fp, "    for (y = 0; y < %d; y++) {\n", h);
+    fprintf(fp, "        for (x = 0; x < %d; x++) {\n", w);
+    fprintf(fp, "            pixels[y][x] = "
+                "shader(x, y, %d, %d, %d, &err) != 0;\n", w, h, t);
+    fprintf(fp, "        }\n");
+    fprintf(fp, "    }\n\n");
+    fprintf(fp, "    if (err) {\n");
+    fprintf(fp, "        printf(\"error\\n\");\n");
+    fprintf(fp, "        return 1;\n");
+    fprintf(fp, "    }\n\n");
+    fprintf(fp, "    printf(\"P1\\n# bitlang test image\\n%%d %%d\\n\", "
+                "%d, %d);\n\n", w, h);
+    fprintf(fp, "    for (y = 0; y < %d; y++) {\n", h);
+    fprintf(fp, "        for (x = 0; x < %d; x++) {\n", w);
+    fprintf(fp, "            if (x != 0) putchar(' ');\n");
+    fprintf(fp, "            putchar(pixels[y][x] ? '1' : '0');\n");
+    fprintf(fp, "        }\n");
+    fprintf(fp, "        putchar('\\n');\n");
+    fprintf(fp, "    }\n\n");
+    fprintf(fp, "    return 0;\n");
+    fprintf(fp, "}\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bitlang vm;
+    bitlang_state st;
+    char bytes[256];
+    int interp;
+    int w, h, t;
+    const char *code;
+
+    interp = 0;
+
+    if (argc > 1 && !strcmp(argv[1], "-i")) {
+        interp = 1;
+        argc--;
+        argv++;
+    }
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: aot [-i] expr [w h t]\n");
+        return 1;
+    }
+
+    code = argv[1];
+    w = argc > 2 ? atoi(argv[2]) : 256;
+    h = argc > 3 ? atoi(argv[3]) : 256;
+    t = argc > 4 ? atoi(argv[4]) : 0;
+
+    bitlang_init(&vm);
+    bitlang_state_init(&st, bytes, 256);
+    bitlang_compile(&st, code);
+
+    if (interp) {
+        unsigned char *pixels;
+        int rc;
+
+        pixels = malloc(w * h);
+        rc = bitlang_render(&vm, &st, w, h, t, pixels);
+
+        if (rc) {
+            printf("error\n");
+            free(pixels);
+            return 1;
+        }
+
+        writepbm(stdout, pixels, w, h);
+        free(pixels);
+        return 0;
+    }
+
+    bitlang_optimize(&st, NULL);
+
+    if (bitlang_emit_c(&st, stdout, "shader")) {
+        fprintf(stderr, "could not generate code for '%s'\n", code);
+        return 1;
+    }
+
+    writemain(stdout, w, h, t);
+
+    return 0;
+}
@@ -0,0 +1,8 @@
+gcc worgle.c -o worglite
+./worglite -g -Werror bitlang.org
+gcc -std=c89 -Wall -pedantic -O3 -g bitlang.c aot.c -o aot
+./aot "${1:-x y + abs x y - abs 1 + ^ 2 << 3 % !}" > aot_shader.c
+gcc -std=c89 -Wall -pedantic -O3 aot_shader.c -o aot_shader
+./aot_shader > aot.pbm
+./aot -i "${1:-x y + abs x y - abs 1 + ^ 2 << 3 % !}" > aot_ref.pbm
+cmp aot.pbm aot_ref.pbm && echo "generated code matches the interpreter"
@@ -0,0 +1,423 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define BITLANG_PRIV
+#include "bitlang.h"
+
+/*
+ * Benchmark suite.
+ *
+ * Every case in the corpus is rendered at several
+ * resolutions, once per mode, and the best of RUNS runs is
+ * reported. Modes are:
+ *
+ * plain: the program as compiled
+ * opt: optimized and verified
+ * jit: optimized, verified, and JIT compiled (only when
+ * the JIT is available)
+ *
+ * Programs are also looked up repeatedly in a
+ * bitlang_cache, to compare with preparing them from
+ * scratch every time.
+ *
+ * Animated programs are also rendered FRAMES frames at a
+ * time, once frame by frame with bitlang_render_bitmap
+ * (loop), and once with bitlang_animate (animate). Their
+ * frames are then delta encoded, decoded again to check
+ * them, and the compression ratio is reported.
+ *
+ * When built with -DBITLANG_PROFILE, the renderer runs
+ * every pixel on the VM, and the time per opcode it
+ * dispatched is reported as well (ns_per_op). Other builds
+ * have no count of what was run, since culled and
+ * replicated pixels never run the program at all, so they
+ * only report pixels per second.
+ *
+ * Output is one line per measurement, made of key=value
+ * pairs, so that it can be diffed and parsed by scripts.
+ */
+
+#define RUNS 3
+#define COMPILES 20000
+#define FRAMES 32
+#define ANIMSIZE 512
+
+typedef struct {
+    const char *name;
+    const char *code;
+} bench_case;
+
+static bench_case corpus[] = {
+    {"foldster", "x y + abs x y - abs 1 + ^ 2 << 3 % !"},
+    {"xorchain", "x y ^ 1 << x ^ 2 >> y ^ 3 << x ^ 1 >> y ^ 5 & !"},
+    {"shiftmask", "x 3 >> y 3 >> ^ x 1 >> y 2 >> & | 1 &"},
+    {"modgrid", "x 7 % y 5 % * x y + 11 % ^ 3 %"},
+    {"moddiv", "x y * 13 / 9 % x y - abs 7 / 5 % = !"},
+    {"constfold", "x 2 3 + * y 4 4 * + ^ 1 1 + 3 << %"},
+    {"separable", "x x * 3 >> 7 % y y * 5 >> 11 % + 3 %"},
+    {"checker", "x 6 >> y 6 >> ^ 1 &"},
+    {"diamond", "x w 2 / - abs y h 2 / - abs + 8 >> !"},
+    {"products", "x y * 5 >> 7 % x y * 5 >> 11 % ^ x y * 5 >> 13 % & 1 &"},
+    {"lazy", "x 6 >> y 6 >> ^ 1 & x y * 7 % 3 / y x - abs 5 >> ^ 1 & ||"},
+    {"select", "y 64 / 2 % x y ^ 3 % x y | 5 % ?"},
+    {NULL, NULL}
+};
+
+static bench_case animations[] = {
+    {"wave", "x x * 3 >> 7 % y y * 5 >> 11 % + t + 3 %"},
+    {"pulse", "x w 2 / - abs y h 2 / - abs + t 7 % 6 + >> !"},
+    {"static", "x y + abs x y - abs 1 + ^ 2 << 3 % !"},
+    {"cycle", "x y + abs t 8 % + x y - abs 1 + ^ 2 << 3 % !"},
+    {NULL, NULL}
+};
+
+static int sizes[] = {256, 1024, 2048, 0};
+
+static const char *modes[] = {"plain", "opt", "jit", NULL};
+
+static double now(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static int prepare(bitlang_state *st, const char *code, int mode)
+{
+    bitlang_compile(st, code);
+
+    if (mode == 0) return 0;
+
+    bitlang_optimize(st, NULL);
+    bitlang_verify(st);
+
+    if (mode == 2) return bitlang_jit(st);
+
+    return 0;
+}
+
+static double dispatches(bitlang *vm)
+{
+    bitlang_profile *p;
+    double n;
+    int i;
+
+    p = bitlang_profile_get(vm);
+    if (p == NULL) return 0;
+
+    n = p->nums;
+    for (i = 0; i < 128; i++) n += p->ops[i];
+
+    return n;
+}
+
+static void bench_render(bench_case *bc, int mode)
+{
+    bitlang vm;
+    bitlang_state st;
+    char bytes[256];
+    bitlang_bitmap bm;
+    unsigned char *pixels;
+    int s;
+    int ops;
+
+    bitlang_init(&vm);
+    bitlang_state_init(&st, bytes, sizeof(bytes));
+
+    if (prepare(&st, bc->code, mode)) return;
+
+    ops = bitlang_ninstr(&st);
+
+    for (s = 0; sizes[s] != 0; s++) {
+        int sz;
+        int r;
+        double best;
+        double best_ops;
+        double pixels_total;
+
+        sz = sizes[s];
+        pixels = malloc(bitlang_bitmap_size(sz, sz));
+        bitlang_bitmap_init(&bm, pixels, sz, sz);
+
+        best = -1;
+        best_ops = 0;
+
+        for (r = 0; r < RUNS; r++) {
+            double t0, t1;
+            int rc;
+
+            bitlang_profile_reset(&vm);
+            t0 = now();
+            rc = bitlang_render_bitmap(&vm, &st, r, &bm);
+            t1 = now();
+
+            if (rc) {
+                printf("bench case=%s mode=%s res=%d error=%d\n",
+                       bc->name, modes[mode], sz, rc);
+                break;
+            }
+
+            if (best < 0 || t1 - t0 < best) {
+                best = t1 - t0;
+                best_ops = dispatches(&vm);
+            }
+        }
+
+        free(pixels);
+
+        if (r < RUNS) continue;
+
+        /* avoid dividing by zero on very fast runs */
+        if (best <= 0) best = 1.0 / CLOCKS_PER_SEC;
+
+        pixels_total = (double)sz * sz;
+
+        printf("bench case=%s mode=%s res=%d runs=%d ops=%d "
+               "pixels_per_sec=%.0f",
+               bc->name, modes[mode], sz, RUNS, ops,
+               pixels_total / best);
+
+        if (best_ops > 0) printf(" ns_per_op=%.3f", best * 1e9 / best_ops);
+
+        printf("\n");
+    }
+
+    bitlang_jit_free(&st);
+}
+
+static int frame_sum(bitlang_bitmap *frame, int t, void *ud)
+{
+    unsigned long *sum;
+
+    sum = ud;
+    *sum += frame->data[0] + t;
+
+    return 0;
+}
+
+static void bench_animate(bench_case *bc)
+{
+    bitlang vm;
+    bitlang_state st;
+    char bytes[256];
+    bitlang_bitmap bm;
+    unsigned char *pixels;
+    bitlang_anim_stats stats;
+    unsigned long sum;
+    double t0, t1;
+    int i;
+    int rc;
+
+    bitlang_init(&vm);
+    bitlang_state_init(&st, bytes, sizeof(bytes));
+    prepare(&st, bc->code, 1);
+
+    pixels = malloc(bitlang_bitmap_size(ANIMSIZE, ANIMSIZE));
+    bitlang_bitmap_init(&bm, pixels, ANIMSIZE, ANIMSIZE);
+
+    sum = 0;
+    rc = 0;
+    t0 = now();
+
+    for (i = 0; i < FRAMES && rc == 0; i++) {
+        rc = bitlang_render_bitmap(&vm, &st, i, &bm);
+        if (rc == 0) rc = frame_sum(&bm, i, &sum);
+    }
+
+    t1 = now();
+    free(pixels);
+
+    if (t1 <= t0) t1 = t0 + 1.0 / CLOCKS_PER_SEC;
+
+    if (rc) {
+        printf("anim case=%s mode=loop res=%d error=%d\n",
+               bc->name, ANIMSIZE, rc);
+    } else {
+        printf("anim case=%s mode=loop res=%d frames=%d fps=%.1f\n",
+               bc->name, ANIMSIZE, FRAMES, FRAMES / (t1 - t0));
+    }
+
+    rc = bitlang_animate(&vm, &st, ANIMSIZE, ANIMSIZE, 0, FRAMES, 1,
+                         frame_sum, &sum, &stats);
+
+    if (rc) {
+        printf("anim case=%s mode=animate res=%d error=%d\n",
+               bc->name, ANIMSIZE, rc);
+        return;
+    }
+
+    printf("anim case=%s mode=animate res=%d frames=%d cached=%d "
+           "fps=%.1f render_secs=%.4f output_secs=%.4f\n",
+           bc->name, ANIMSIZE, stats.frames, stats.cached, stats.fps,
+           stats.render_secs, stats.output_secs);
+}
+
+typedef struct {
+    bitlang_bitmap prev;
+    bitlang_bitmap copy;
+    unsigned char *buf;
+    size_t max;
+    double raw;
+    double coded;
+    double secs;
+} delta_run;
+
+static int frame_delta(bitlang_bitmap *frame, int t, void *ud)
+{
+    delta_run *dr;
+    size_t sz;
+    size_t len;
+    double t0;
+
+    dr = ud;
+    sz = bitlang_bitmap_size(frame->w, frame->h);
+
+    t0 = now();
+    if (bitlang_delta_encode(t ? &dr->prev : NULL, frame,
+                             dr->buf, dr->max, &len)) {
+        return 1;
+    }
+    dr->secs += now() - t0;
+
+    if (bitlang_delta_decode(&dr->copy, dr->buf, len)) return 2;
+    if (memcmp(dr->copy.data, frame->data, sz)) return 3;
+
+    memcpy(dr->prev.data, frame->data, sz);
+    dr->raw += sz;
+    dr->coded += len;
+
+    return 0;
+}
+
+static void bench_delta(bench_case *bc)
+{
+    bitlang vm;
+    bitlang_state st;
+    char bytes[256];
+    delta_run dr;
+    int sz;
+    int rc;
+
+    bitlang_init(&vm);
+    bitlang_state_init(&st, bytes, sizeof(bytes));
+    prepare(&st, bc->code, 1);
+
+    sz = bitlang_bitmap_size(ANIMSIZE, ANIMSIZE);
+    dr.max = bitlang_delta_bound(ANIMSIZE, ANIMSIZE);
+    dr.buf = malloc(dr.max);
+    bitlang_bitmap_init(&dr.prev, malloc(sz), ANIMSIZE, ANIMSIZE);
+    bitlang_bitmap_init(&dr.copy, malloc(sz), ANIMSIZE, ANIMSIZE);
+    dr.raw = 0;
+    dr.coded = 0;
+    dr.secs = 0;
+
+    rc = bitlang_animate(&vm, &st, ANIMSIZE, ANIMSIZE, 0, FRAMES, 1,
+                         frame_delta, &dr, NULL);
+
+    if (rc) {
+        printf("delta case=%s res=%d error=%d\n", bc->name, ANIMSIZE, rc);
+    } else {
+        if (dr.secs <= 0) dr.secs = 1.0 / CLOCKS_PER_SEC;
+        printf("delta case=%s res=%d frames=%d raw_bytes=%.0f "
+               "delta_bytes=%.0f ratio=%.2f encode_mb_per_sec=%.1f\n",
+               bc->name, ANIMSIZE, FRAMES, dr.raw, dr.coded,
+               dr.raw / dr.coded, dr.raw / dr.secs / 1e6);
+    }
+
+    free(dr.buf);
+    free(dr.prev.data);
+    free(dr.copy.data);
+}
+
+static void bench_compile(bench_case *bc)
+{
+    bitlang_state st;
+    char bytes[256];
+    int i;
+    double t0, t1;
+
+    t0 = now();
+
+    for (i = 0; i < COMPILES; i++) {
+        bitlang_state_init(&st, bytes, sizeof(bytes));
+        bitlang_compile(&st, bc->code);
+    }
+
+    t1 = now();
+
+    if (t1 <= t0) t1 = t0 + 1.0 / CLOCKS_PER_SEC;
+
+    printf("compile case=%s compiles=%d compiles_per_sec=%.0f\n",
+           bc->name, COMPILES, COMPILES / (t1 - t0));
+}
+
+/*
+ * Compiles, optimizes, verifies, and JIT compiles a program
+ * from scratch COMPILES times, and then looks it up that
+ * many times in a cache, written a different way each time
+ * around so that only the first lookup has to compile it.
+ */
+
+static bitlang_cache cache;
+
+static void bench_cache(bench_case *bc)
+{
+    bitlang_state st;
+    char bytes[256];
+    char src[BITLANG_CACHE_SRC];
+    bitlang_cache_stats *stats;
+    int i;
+    double t0, t1, t2;
+
+    t0 = now();
+
+    for (i = 0; i < COMPILES; i++) {
+        bitlang_state_init(&st, bytes, sizeof(bytes));
+        prepare(&st, bc->code, 2);
+        bitlang_jit_free(&st);
+    }
+
+    t1 = now();
+
+    bitlang_cache_init(&cache, 1);
+
+    for (i = 0; i < COMPILES; i++) {
+        sprintf(src, "%*s%s", i % 4, "", bc->code);
+        if (bitlang_cache_get(&cache, src) == NULL) break;
+    }
+
+    t2 = now();
+
+    stats = bitlang_cache_stats_get(&cache);
+
+    if (t1 <= t0) t1 = t0 + 1.0 / CLOCKS_PER_SEC;
+    if (t2 <= t1) t2 = t1 + 1.0 / CLOCKS_PER_SEC;
+
+    printf("cache case=%s lookups=%d prepares_per_sec=%.0f "
+           "lookups_per_sec=%.0f hits=%lu misses=%lu\n",
+           bc->name, i, COMPILES / (t1 - t0), i / (t2 - t1),
+           stats->hits, stats->misses);
+
+    bitlang_cache_free(&cache);
+}
+
+int main(void)
+{
+    int c;
+    int m;
+
+    for (c = 0; corpus[c].name != NULL; c++) {
+        bench_compile(&corpus[c]);
+        bench_cache(&corpus[c]);
+
+        for (m = 0; modes[m] != NULL; m++) {
+            bench_render(&corpus[c], m);
+        }
+    }
+
+    for (c = 0; animations[c].name != NULL; c++) {
+        bench_animate(&animations[c]);
+        bench_delta(&animations[c]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,5 @@
+# ns_per_op is only reported with -DBITLANG_PROFILE, see README.md
+gcc worgle.c -o worglite
+./worglite -g -Werror bitlang.org
+gcc -std=c89 -Wall -pedantic -O3 -g "$@" bitlang.c bench.c -o bench
+./bench
@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define BITLANG_PRIV
+#include "bitlang.h"
+
+/*
+ * Consistency checks.
+ *
+ * Every case is first run pixel by pixel with bitlang_exec,
+ * which is the reference, and which must fail exactly when
+ * the case says it does. It is then rendered once per mode,
+ * with bitlang_render and with bitlang_render_mt, and each
+ * frame must fail when the reference does, and match it
+ * pixel for pixel when it doesn't. Modes are the same as
+ * in the benchmark suite:
+ *
+ * plain: the program as compiled
+ * opt: optimized and verified
+ * jit: optimized, verified, and JIT compiled (only when
+ * the JIT is available)
+ *
+ * Animated cases are rendered FRAMES frames at a time with
+ * bitlang_animate, starting at their t, once per mode and
+ * with and without threads. Every frame handed over must
+ * match the reference for its t, and the animation must
+ * fail exactly when one of its frames does.
+ *
+ * One line is printed per case and mode, with the number
+ * of pixels that differ for each engine, or -1 if only one
+ * of the two failed. The exit status is non-zero if any of
+ * them didn't match.
+ */
+
+#define THREADS 4
+#define FRAMES 8
+
+typedef struct {
+    const char *name;
+    const char *code;
+    int w, h, t;
+    int fails;
+} check_case;
+
+static check_case cases[] = {
+    {"foldster", "x y + abs x y - abs 1 + ^ 2 << 3 % !", 67, 45, 0, 0},
+    /* INT_MIN % -1 is 0, without trapping */
+    {"intmin_mod", "2147483648 x + y 3 & 2 - %", 67, 45, 0, 0},
+    /* INT_MIN / -1 fails, without trapping */
+    {"intmin_div", "2147483648 x + y 3 & 2 - /", 67, 45, 0, 1},
+    /* values below the top of the stack fail, with a longer period */
+    {"period_lower", "7 14 y ^ 5 & / x", 67, 45, 0, 1},
+    {"period_lower_x", "x 2147483647 x h & ! / 16 y", 67, 45, 0, 1},
+    /* registers carry values from one pixel to the next */
+    {"carry", "5 get 1 + dup 5 set 1 &", 67, 45, 0, 0},
+    {"carry_get", "x 7 & get ! dup 111828 7 set", 67, 45, 0, 0},
+    /* operands longer than 127 bytes are skipped too */
+    {"skip_long", "x 0 = 100 x / "
+     "x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + "
+     "x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + "
+     "x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + "
+     "x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + "
+     "x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + "
+     "1 & ||", 67, 45, 0, 0},
+    {NULL, NULL, 0, 0, 0, 0}
+};
+
+static check_case animations[] = {
+    {"static", "x y + abs x y - abs 1 + ^ 2 << 3 % !", 16, 16, 1, 0},
+    {"cycle", "x y + abs t 8 % + x y - abs 1 + ^ 2 << 3 % !", 16, 16, 1, 0},
+    /* values below the top of the stack fail every 4 frames */
+    {"cycle_lower", "7 t 3 & / x", 16, 16, 1, 1},
+    {NULL, NULL, 0, 0, 0, 0}
+};
+
+typedef struct {
+    check_case cc;
+    unsigned char *ref;
+    int frames;
+    int ndiff;
+} check_anim;
+
+static const char *modes[] = {"plain", "opt", "jit", NULL};
+
+static int prepare(bitlang_state *st, const char *code, int mode)
+{
+    if (bitlang_compile(st, code)) return 1;
+
+    if (mode == 0) return 0;
+
+    bitlang_optimize(st, NULL);
+    bitlang_verify(st);
+
+    if (mode == 2) return bitlang_jit(st);
+
+    return 0;
+}
+
+static int reference(check_case *cc, unsigned char *pixels)
+{
+    bitlang vm;
+    bitlang_state st;
+    char bytes[1024];
+    int x, y;
+    int err;
+
+    bitlang_init(&vm);
+    bitlang_state_init(&st, bytes, sizeof(bytes));
+    bitlang_compile(&st, cc->code);
+    bitlang_regset(&vm, 2, cc->w);
+    bitlang_regset(&vm, 3, cc->h);
+    bitlang_regset(&vm, 4, cc->t);
+
+    err = 0;
+
+    for (y = 0; y < cc->h; y++) {
+        for (x = 0; x < cc->w; x++) {
+            int val;
+
+            bitlang_reset(&vm);
+            bitlang_regset(&vm, 0, x);
+            bitlang_regset(&vm, 1, y);
+            val = 0;
+
+            if (bitlang_exec(&vm, &st) || bitlang_pop(&vm, &val)) {
+                err = 1;
+            }
+
+            pixels[y*cc->w + x] = val != 0;
+        }
+    }
+
+    return err;
+}
+
+static int compare(check_case *cc, int err, unsigned char *ref,
+                   int rc, unsigned char *pixels)
+{
+    int i;
+    int ndiff;
+
+    if ((rc != 0) != err) return -1;
+    if (err) return 0;
+
+    ndiff = 0;
+
+    for (i = 0; i < cc->w * cc->h; i++) {
+        if (pixels[i] != ref[i]) ndiff++;
+    }
+
+    return ndiff;
+}
+
+static int check(check_case *cc)
+{
+    unsigned char *ref;
+    unsigned char *pixels;
+    int err;
+    int mode;
+    int failed;
+
+    ref = malloc(cc->w * cc->h);
+    pixels = malloc(cc->w * cc->h);
+    failed = 0;
+
+    err = reference(cc, ref);
+
+    if (err != cc->fails) {
+        printf("check case=%s reference error=%d expected=%d FAIL\n",
+               cc->name, err, cc->fails);
+        free(ref);
+        free(pixels);
+        return 1;
+    }
+
+    for (mode = 0; modes[mode] != NULL; mode++) {
+        bitlang vm;
+        bitlang_state st;
+        char bytes[1024];
+        int rc, rc_mt;
+        int diff, diff_mt;
+
+        bitlang_init(&vm);
+        bitlang_state_init(&st, bytes, sizeof(bytes));
+
+        if (prepare(&st, cc->code, mode)) continue;
+
+        rc = bitlang_render(&vm, &st, cc->w, cc->h, cc->t, pixels);
+        diff = compare(cc, err, ref, rc, pixels);
+        bitlang_init(&vm);
+        rc_mt = bitlang_render_mt(&vm, &st, cc->w, cc->h, cc->t,
+                                  pixels, THREADS);
+        diff_mt = compare(cc, err, ref, rc_mt, pixels);
+
+        printf("check case=%s mode=%s error=%d "
+               "render=%d render_mt=%d %s\n",
+               cc->name, modes[mode], err, diff, diff_mt,
+               diff || diff_mt ? "FAIL" : "ok");
+
+        if (diff || diff_mt) failed = 1;
+
+        bitlang_jit_free(&st);
+    }
+
+    free(ref);
+    free(pixels);
+    return failed;
+}
+
+static int check_frame(bitlang_bitmap *frame, int t, void *ud)
+{
+    check_anim *ca;
+    int x, y;
+
+    ca = ud;
+    ca->cc.t = t;
+    ca->frames++;
+
+    if (reference(&ca->cc, ca->ref)) {
+        ca->ndiff = -1;
+        return 0;
+    }
+
+    for (y = 0; y < frame->h; y++) {
+        for (x = 0; x < frame->w; x++) {
+            if (bitlang_bitmap_get(frame, x, y) != ca->ref[y*frame->w + x]) {
+                ca->ndiff++;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int animate(check_case *cc, bitlang_state *st, int nthreads,
+                   int err)
+{
+    bitlang vm;
+    bitlang_anim_stats stats;
+    check_anim ca;
+    int rc;
+
+    ca.cc = *cc;
+    ca.ref = malloc(cc->w * cc->h);
+    ca.frames = 0;
+    ca.ndiff = 0;
+
+    bitlang_init(&vm);
+    rc = bitlang_animate(&vm, st, cc->w, cc->h, cc->t, FRAMES,
+                         nthreads, check_frame, &ca, &stats);
+
+    free(ca.ref);
+
+    if (ca.ndiff) return ca.ndiff;
+    if ((rc != 0) != err) return -1;
+    if (!err && ca.frames != FRAMES) return -1;
+
+    return 0;
+}
+
+static int check_animate(check_case *cc)
+{
+    unsigned char *ref;
+    check_case frame;
+    int err;
+    int mode;
+    int n;
+    int failed;
+
+    ref = malloc(cc->w * cc->h);
+    frame = *cc;
+    err = 0;
+    failed = 0;
+
+    for (n = 0; n < FRAMES; n++) {
+        frame.t = cc->t + n;
+        if (reference(&frame, ref)) err = 1;
+    }
+
+    free(ref);
+
+    if (err != cc->fails) {
+        printf("check animation=%s reference error=%d expected=%d FAIL\n",
+               cc->name, err, cc->fails);
+        return 1;
+    }
+
+    for (mode = 0; modes[mode] != NULL; mode++) {
+        bitlang_state st;
+        char bytes[1024];
+        int diff, diff_mt;
+
+        bitlang_state_init(&st, bytes, sizeof(bytes));
+
+        if (prepare(&st, cc->code, mode)) continue;
+
+        diff = animate(cc, &st, 1, err);
+        diff_mt = animate(cc, &st, THREADS, err);
+
+        printf("check animation=%s mode=%s error=%d "
+               "animate=%d animate_mt=%d %s\n",
+               cc->name, modes[mode], err, diff, diff_mt,
+               diff || diff_mt ? "FAIL" : "ok");
+
+        if (diff || diff_mt) failed = 1;
+
+        bitlang_jit_free(&st);
+    }
+
+    return failed;
+}
+
+int main(void)
+{
+    int i;
+    int failed;
+
+    failed = 0;
+
+    for (i = 0; cases[i].name != NULL; i++) {
+        if (check(&cases[i])) failed = 1;
+    }
+
+    for (i = 0; animations[i].name != NULL; i++) {
+        if (check_animate(&animations[i])) failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,4 @@
+gcc worgle.c -o worglite
+./worglite -g -Werror bitlang.org
+gcc -std=c89 -Wall -pedantic -O3 -g "$@" bitlang.c check.c -o check
+./check
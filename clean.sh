@@ -1 +1 @@
-rm -f bitlang.c bitlang.h example
+rm -f bitlang.c bitlang.h worglite example example.pbm aot aot_shader aot_shader.c aot.pbm aot_ref.pbm bench check
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #define BITLANG_PRIV
 #include "bitlang.h"
 
@@ -8,7 +9,9 @@ int main(int argc, char *argv[])
     bitlang vm;
     bitlang_state st;
     char bytes[128];
-    int x, y;
+    bitlang_bitmap bm;
+    unsigned char *pixels;
+    int rc;
     FILE *fp;
 
     sz = 256;
@@ -20,47 +23,24 @@ int main(int argc, char *argv[])
     /* this is a formula based on one by Foldster */
     bitlang_compile(&st, "x y + abs x y - abs 1 + ^ 2 << 3 % !");
 
-    /* width, linked to 'w' */
-    bitlang_regset(&vm, 2, sz);
-    /* height, linked to 'h' */
-    bitlang_regset(&vm, 3, sz);
+    /* 1-bit image, 8 pixels per byte */
+    pixels = malloc(bitlang_bitmap_size(sz, sz));
+    bitlang_bitmap_init(&bm, pixels, sz, sz);
 
-    fp = fopen("example.pbm", "w");
+    /* evaluate every pixel in the frame at time 0 */
+    rc = bitlang_render_bitmap(&vm, &st, 0, &bm);
 
-    /* PBM header */
-    fprintf(fp, "P1\n# bitlang test image\n%d %d\n", sz, sz);
-
-    for (y = 0; y < sz; y++) {
-        for (x = 0; x < sz; x++) {
-            int val, rc;
-            val = 0;
-
-            /* x, y coordinates are registers 0 and 1 */
-
-            bitlang_regset(&vm, 0, x);
-            bitlang_regset(&vm, 1, y);
-            bitlang_reset(&vm);
-
-            rc = bitlang_exec(&vm, &st);
-
-            if (rc) {
-                printf("error\n");
-                break;
-            }
-
-            if (x != 0) {
-                fputc(' ', fp);
-            }
-
-            bitlang_pop(&vm, &val);
-
-            if (val) fputc('1', fp);
-            else fputc('0', fp);
-        }
-
-        fputc('\n', fp);
+    if (rc) {
+        printf("error\n");
+        free(pixels);
+        return 1;
     }
 
+    /* write it out as a binary PBM */
+    fp = fopen("example.pbm", "wb");
+    bitlang_pbm_write(fp, &bm);
     fclose(fp);
+
+    free(pixels);
     return 0;
 }